@@ -0,0 +1,227 @@
+#include "../search-server/line_server.h"
+#include "../search-server/search_server.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define LINE_SERVER_HAS_UNIX_SOCKETS
+#endif
+
+using namespace std;
+
+// Без --socket команды читаются из stdin, ответы пишутся в stdout,
+// по завершении в stderr выводится пропускная способность в запросах в секунду
+const string USAGE = "Использование: line-server [--stop-words \"и в на\"] [--workers N] [--socket PATH] "s
+                     "[--memory-limit BYTES --spill-file PATH]"s;
+
+int PrintUsageError(const string& message)
+{
+    cerr << message << '\n' << USAGE << endl;
+    return 1;
+}
+
+// В отличие от stoul, не принимает знак, пробелы и хвост после числа
+bool ParseSize(const string& text, size_t& value)
+{
+    if (text.empty() || text.find_first_not_of("0123456789"s) != string::npos)
+    {
+        return false;
+    }
+    try
+    {
+        value = stoul(text);
+    }
+    catch (const out_of_range&)
+    {
+        return false;
+    }
+    return true;
+}
+
+#ifdef LINE_SERVER_HAS_UNIX_SOCKETS
+// Буферизованный поток поверх дескриптора сокета
+class FdStreamBuf : public streambuf
+{
+public:
+
+    explicit FdStreamBuf(int fd)
+        : fd_(fd)
+        , input_(1 << 16)
+        , output_(1 << 16)
+    {
+        setg(input_.data(), input_.data(), input_.data());
+        setp(output_.data(), output_.data() + output_.size());
+    }
+
+    ~FdStreamBuf() override
+    {
+        sync();
+    }
+
+protected:
+
+    int_type underflow() override
+    {
+        const ssize_t count = read(fd_, input_.data(), input_.size());
+        if (count <= 0)
+        {
+            return traits_type::eof();
+        }
+        setg(input_.data(), input_.data(), input_.data() + count);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        if (sync() != 0)
+        {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        for (const char* data = pbase(); data < pptr();)
+        {
+            const ssize_t count = write(fd_, data, pptr() - data);
+            if (count <= 0)
+            {
+                return -1;
+            }
+            data += count;
+        }
+        setp(output_.data(), output_.data() + output_.size());
+        return 0;
+    }
+
+private:
+
+    int fd_;
+    vector<char> input_;
+    vector<char> output_;
+};
+
+int ServeUnixSocket(SearchServer& search_server, const string& path, const LineServerOptions& options)
+{
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || path.size() >= sizeof(address.sun_path))
+    {
+        cerr << "Не удалось создать сокет "s << path << endl;
+        return 1;
+    }
+    path.copy(address.sun_path, path.size());
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0)
+    {
+        cerr << "Не удалось открыть сокет "s << path << endl;
+        close(listener);
+        return 1;
+    }
+
+    // соединения обслуживаются по очереди, индекс общий для всех клиентов
+    for (int client; (client = accept(listener, nullptr, nullptr)) >= 0;)
+    {
+        {
+            FdStreamBuf buffer(client);
+            istream in(&buffer);
+            ostream out(&buffer);
+            const LineServerStats stats = RunLineServer(search_server, in, out, options);
+            cerr << "Соединение закрыто: "s << stats.queries << " запросов, "s
+                 << stats.GetQueriesPerSecond() << " запросов/с"s << endl;
+        }
+        close(client);
+    }
+    close(listener);
+    return 0;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    string stop_words;
+    string socket_path;
+    string spill_path = "search-server.spill"s;
+    size_t memory_limit = 0;
+    LineServerOptions options;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        const string option = argv[i];
+        if (i + 1 == argc)
+        {
+            return PrintUsageError("Не задано значение параметра "s + option);
+        }
+        const string value = argv[i + 1];
+        if (option == "--stop-words"s)
+        {
+            stop_words = value;
+        }
+        else if (option == "--workers"s)
+        {
+            if (!ParseSize(value, options.worker_count))
+            {
+                return PrintUsageError("Некорректное число потоков: "s + value);
+            }
+        }
+        else if (option == "--socket"s)
+        {
+            socket_path = value;
+        }
+        else if (option == "--memory-limit"s)
+        {
+            if (!ParseSize(value, memory_limit))
+            {
+                return PrintUsageError("Некорректный лимит памяти: "s + value);
+            }
+        }
+        else if (option == "--spill-file"s)
+        {
+            spill_path = value;
+        }
+        else
+        {
+            return PrintUsageError("Неизвестный параметр "s + option);
+        }
+    }
+
+    SearchServer search_server(stop_words);
+    if (memory_limit > 0)
+    {
+        search_server.SetMemoryLimit(memory_limit, spill_path);
+    }
+
+    if (!socket_path.empty())
+    {
+#ifdef LINE_SERVER_HAS_UNIX_SOCKETS
+        return ServeUnixSocket(search_server, socket_path, options);
+#else
+        cerr << "Unix-сокеты не поддерживаются на этой платформе"s << endl;
+        return 1;
+#endif
+    }
+
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+
+    const LineServerStats stats = RunLineServer(search_server, cin, cout, options);
+    cerr << "Обработано запросов: "s << stats.queries << " за "s << stats.seconds << " с, "s
+         << stats.GetQueriesPerSecond() << " запросов/с"s << endl;
+
+    return 0;
+}
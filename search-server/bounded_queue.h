@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+// Потокобезопасная очередь ограниченной ёмкости. Push блокируется, пока очередь
+// заполнена (обратное давление на производителя), Pop — пока она пуста
+template <typename T>
+class BoundedQueue
+{
+public:
+
+    explicit BoundedQueue(std::size_t capacity)
+        : capacity_(capacity)
+        {}
+
+    // возвращает false, если очередь уже закрыта
+    bool Push(T value);
+    // возвращает пустой optional, когда очередь закрыта и опустела
+    std::optional<T> Pop();
+    void Close();
+
+private:
+
+    const std::size_t capacity_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+template <typename T>
+bool BoundedQueue<T>::Push(T value)
+{
+    std::unique_lock lock(mutex_);
+    not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+    if (closed_)
+    {
+        return false;
+    }
+    items_.push_back(std::move(value));
+    lock.unlock();
+    not_empty_.notify_one();
+
+    return true;
+}
+
+template <typename T>
+std::optional<T> BoundedQueue<T>::Pop()
+{
+    std::unique_lock lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty())
+    {
+        return std::nullopt;
+    }
+    T value = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+
+    return value;
+}
+
+template <typename T>
+void BoundedQueue<T>::Close()
+{
+    {
+        std::lock_guard guard(mutex_);
+        closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+}
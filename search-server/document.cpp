@@ -14,22 +14,25 @@ std::ostream& operator << (std::ostream& out, const Document& document)
 
 void PrintDocument(const Document& document) 
 {
-    std::cout << "{ "s
-        << "document_id = "s << document.id << ", "s
-        << "relevance = "s << document.relevance << ", "s
-        << "rating = "s << document.rating << " }"s << std::endl;
+    // '\n' вместо std::endl: сброс буфера на каждой строке заметно замедляет вывод
+    std::cout << document << '\n';
 }
 
 void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status) 
 {
-    std::cout << "{ "s
+    PrintMatchDocumentResult(std::cout, document_id, words, status);
+}
+
+void PrintMatchDocumentResult(std::ostream& out, int document_id, const std::vector<std::string>& words, DocumentStatus status) 
+{
+    out << "{ "s
         << "document_id = "s << document_id << ", "s
         << "status = "s << static_cast<int>(status) << ", "s
         << "words ="s;
         
     for (const std::string& word : words) 
     {
-        std::cout << ' ' << word;
+        out << ' ' << word;
     }
-    std::cout << "}"s << std::endl;
+    out << "}"s << '\n';
 }
\ No newline at end of file
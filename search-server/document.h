@@ -29,4 +29,5 @@ enum class DocumentStatus
 
 std::ostream& operator << (std::ostream& out, const Document& document);
 void PrintDocument(const Document& document);
-void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status);
\ No newline at end of file
+void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status);
+void PrintMatchDocumentResult(std::ostream& out, int document_id, const std::vector<std::string>& words, DocumentStatus status);
\ No newline at end of file
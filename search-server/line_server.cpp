@@ -0,0 +1,370 @@
+#include "line_server.h"
+#include "bounded_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::string_literals;
+
+double LineServerStats::GetQueriesPerSecond() const
+{
+    return seconds > 0.0 ? queries / seconds : 0.0;
+}
+
+namespace
+{
+
+enum class CommandType
+{
+    SEARCH,
+    MATCH
+};
+
+struct Task
+{
+    std::size_t sequence;
+    CommandType type;
+    int document_id;
+    std::string query;
+};
+
+struct Response
+{
+    std::size_t sequence;
+    std::string text;
+    // отправить накопленный вывод после всех предыдущих ответов
+    bool flush = false;
+};
+
+std::vector<int> ParseRatings(const std::string& text)
+{
+    std::vector<int> ratings;
+    if (text == "-"s)
+    {
+        return ratings;
+    }
+    std::istringstream stream(text);
+    for (std::string rating; getline(stream, rating, ',');)
+    {
+        ratings.push_back(std::stoi(rating));
+    }
+    return ratings;
+}
+
+// Отделяет первое слово строки, остаток строки возвращается через rest
+std::string SplitFirstWord(const std::string& line, std::string& rest)
+{
+    const auto begin = line.find_first_not_of(' ');
+    if (begin == std::string::npos)
+    {
+        rest.clear();
+        return {};
+    }
+    const auto end = line.find(' ', begin);
+    if (end == std::string::npos)
+    {
+        rest.clear();
+        return line.substr(begin);
+    }
+    rest = line.substr(end + 1);
+    return line.substr(begin, end - begin);
+}
+
+class LinePipeline
+{
+public:
+
+    LinePipeline(SearchServer& search_server, std::istream& in, std::ostream& out,
+                 const LineServerOptions& options)
+        : search_server_(search_server)
+        , in_(in)
+        , out_(out)
+        , options_(options)
+        , tasks_(options.queue_capacity)
+        , responses_(options.queue_capacity)
+        {}
+
+    LineServerStats Run();
+
+private:
+
+    SearchServer& search_server_;
+    std::istream& in_;
+    std::ostream& out_;
+    const LineServerOptions options_;
+
+    BoundedQueue<Task> tasks_;
+    BoundedQueue<Response> responses_;
+
+    std::atomic<std::size_t> queries_ = 0;
+    std::size_t commands_ = 0;
+    std::chrono::steady_clock::time_point start_time_;
+
+    // число запросов, переданных рабочим потокам и ещё не получивших ответ
+    std::size_t in_flight_ = 0;
+    std::mutex in_flight_mutex_;
+    std::condition_variable idle_;
+
+    // Окно переупорядочивания: номера, выданные парсером и ещё не выведенные писателем.
+    // Ограничено queue_capacity, иначе медленный запрос копил бы у писателя все ответы после себя
+    std::size_t next_sequence_ = 0;
+    std::size_t unwritten_ = 0;
+    std::mutex window_mutex_;
+    std::condition_variable window_not_full_;
+
+    void ParseCommands();
+    void ParseCommand(std::string line);
+    void ProcessTasks();
+    void WriteResponses();
+
+    std::size_t NextSequence();
+    void Dispatch(Task task);
+    void WaitForIdle();
+    std::string ExecuteAdd(const std::string& arguments);
+    std::string ExecuteTask(const Task& task) const;
+    std::string FormatStats() const;
+};
+
+LineServerStats LinePipeline::Run()
+{
+    start_time_ = std::chrono::steady_clock::now();
+
+    std::thread writer(&LinePipeline::WriteResponses, this);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, options_.worker_count); ++i)
+    {
+        workers.emplace_back(&LinePipeline::ProcessTasks, this);
+    }
+    std::thread parser(&LinePipeline::ParseCommands, this);
+
+    parser.join();
+    tasks_.Close();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    responses_.Close();
+    writer.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time_;
+    return { commands_, queries_.load(), elapsed.count() };
+}
+
+void LinePipeline::ParseCommands()
+{
+    for (std::string line; getline(in_, line);)
+    {
+        ParseCommand(line);
+
+        // дальше чтение заблокируется: клиент ждёт ответов на уже отправленные команды
+        if (in_.rdbuf()->in_avail() <= 0)
+        {
+            responses_.Push({ NextSequence(), {}, true });
+        }
+    }
+    WaitForIdle();
+}
+
+void LinePipeline::ParseCommand(std::string line)
+{
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.pop_back();
+    }
+    std::string arguments;
+    const std::string command = SplitFirstWord(line, arguments);
+    if (command.empty())
+    {
+        return;
+    }
+    ++commands_;
+
+    if (command == "search"s)
+    {
+        Dispatch({ NextSequence(), CommandType::SEARCH, 0, arguments });
+    }
+    else if (command == "match"s)
+    {
+        std::string query;
+        const std::string document_id = SplitFirstWord(arguments, query);
+        int id = 0;
+        try
+        {
+            id = std::stoi(document_id);
+        }
+        catch (const std::exception&)
+        {
+            responses_.Push({ NextSequence(), "Ошибка матчинга: некорректный id документа "s + document_id + "\n"s });
+            return;
+        }
+        Dispatch({ NextSequence(), CommandType::MATCH, id, query });
+    }
+    else if (command == "add"s)
+    {
+        // изменение индекса не должно пересекаться с выполняемыми запросами
+        WaitForIdle();
+        responses_.Push({ NextSequence(), ExecuteAdd(arguments) });
+    }
+    else if (command == "stats"s)
+    {
+        WaitForIdle();
+        responses_.Push({ NextSequence(), FormatStats() });
+    }
+    else
+    {
+        responses_.Push({ NextSequence(), "Неизвестная команда: "s + command + "\n"s });
+    }
+}
+
+void LinePipeline::ProcessTasks()
+{
+    while (auto task = tasks_.Pop())
+    {
+        responses_.Push({ task->sequence, ExecuteTask(*task) });
+        ++queries_;
+
+        std::lock_guard guard(in_flight_mutex_);
+        if (--in_flight_ == 0)
+        {
+            idle_.notify_all();
+        }
+    }
+}
+
+void LinePipeline::WriteResponses()
+{
+    std::map<std::size_t, Response> pending;
+    std::size_t next_sequence = 0;
+    std::string buffer;
+
+    const auto flush = [this, &buffer]
+    {
+        if (!buffer.empty())
+        {
+            out_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            out_.flush();
+            buffer.clear();
+        }
+    };
+
+    // Вывод отправляется при заполнении буфера, по маркеру от парсера, который
+    // вот-вот заблокируется на чтении, и в конце ввода
+    while (auto response = responses_.Pop())
+    {
+        pending.emplace(response->sequence, std::move(*response));
+
+        std::size_t written = 0;
+        for (auto it = pending.begin(); it != pending.end() && it->first == next_sequence;
+             it = pending.erase(it), ++next_sequence, ++written)
+        {
+            buffer += it->second.text;
+            if (it->second.flush || buffer.size() >= options_.output_buffer_size)
+            {
+                flush();
+            }
+        }
+
+        if (written > 0)
+        {
+            {
+                std::lock_guard guard(window_mutex_);
+                unwritten_ -= written;
+            }
+            window_not_full_.notify_one();
+        }
+    }
+    flush();
+}
+
+std::size_t LinePipeline::NextSequence()
+{
+    // ответ с самым ранним номером уже выдан, поэтому окно обязательно освободится
+    std::unique_lock lock(window_mutex_);
+    window_not_full_.wait(lock, [this] { return unwritten_ < options_.queue_capacity; });
+    ++unwritten_;
+    return next_sequence_++;
+}
+
+void LinePipeline::Dispatch(Task task)
+{
+    {
+        std::lock_guard guard(in_flight_mutex_);
+        ++in_flight_;
+    }
+    tasks_.Push(std::move(task));
+}
+
+void LinePipeline::WaitForIdle()
+{
+    std::unique_lock lock(in_flight_mutex_);
+    idle_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+std::string LinePipeline::ExecuteAdd(const std::string& arguments)
+{
+    std::string rest;
+    std::string text;
+    const std::string document_id = SplitFirstWord(arguments, rest);
+    const std::string ratings = SplitFirstWord(rest, text);
+    try
+    {
+        search_server_.AddDocument(std::stoi(document_id), text, DocumentStatus::ACTUAL, ParseRatings(ratings));
+    }
+    catch (const std::exception& e)
+    {
+        return "Ошибка добавления документа "s + document_id + ": "s + e.what() + "\n"s;
+    }
+    return "Документ "s + document_id + " добавлен\n"s;
+}
+
+std::string LinePipeline::ExecuteTask(const Task& task) const
+{
+    std::ostringstream out;
+    try
+    {
+        if (task.type == CommandType::SEARCH)
+        {
+            out << "Результаты поиска по запросу: "s << task.query << '\n';
+            for (const Document& document : search_server_.FindTopDocuments(task.query))
+            {
+                out << document << '\n';
+            }
+        }
+        else
+        {
+            const auto [words, status] = search_server_.MatchDocument(task.query, task.document_id);
+            PrintMatchDocumentResult(out, task.document_id, words, status);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        out << "Ошибка обработки запроса "s << task.query << ": "s << e.what() << '\n';
+    }
+    return out.str();
+}
+
+std::string LinePipeline::FormatStats() const
+{
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time_;
+    const LineServerStats stats{ commands_, queries_.load(), elapsed.count() };
+
+    std::ostringstream out;
+    out << "Обработано запросов: "s << stats.queries << " за "s << stats.seconds << " с, "s
+        << stats.GetQueriesPerSecond() << " запросов/с\n"s;
+    return out.str();
+}
+
+} // namespace
+
+LineServerStats RunLineServer(SearchServer& search_server, std::istream& in, std::ostream& out,
+                              const LineServerOptions& options)
+{
+    LinePipeline pipeline(search_server, in, out, options);
+    return pipeline.Run();
+}
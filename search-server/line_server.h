@@ -0,0 +1,38 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+
+// Построчный протокол:
+//   add <id> <рейтинги через запятую или -> <текст документа>
+//   search <запрос>
+//   match <id> <запрос>
+//   stats
+// Каждая команда порождает ответ; ответы выводятся в порядке поступления команд
+
+struct LineServerOptions
+{
+    std::size_t worker_count = std::max(1u, std::thread::hardware_concurrency());
+    // ёмкость очередей и число ответов, ожидающих вывода по порядку
+    std::size_t queue_capacity = 1024;
+    std::size_t output_buffer_size = 1 << 16;
+};
+
+struct LineServerStats
+{
+    std::size_t commands = 0;
+    std::size_t queries = 0;
+    double seconds = 0.0;
+
+    double GetQueriesPerSecond() const;
+};
+
+// Конвейер: поток разбора команд -> пул потоков поиска -> упорядочивающий писатель.
+// Стадии связаны очередями ограниченной ёмкости. Команды add выполняются как барьер:
+// после всех ранее принятых запросов и до всех последующих
+LineServerStats RunLineServer(SearchServer& search_server, std::istream& in, std::ostream& out,
+                              const LineServerOptions& options = {});
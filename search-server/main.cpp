@@ -2,13 +2,21 @@
 #include "read_input_functions.h"
 #include "request_queue.h"
 #include "search_server.h"
+#include "test_example_functions.h"
 
 #include <iostream>
 
 using namespace std;
 
-int main() 
+int main(int argc, char* argv[]) 
 {
+    TestSearchServer();
+    if (argc > 1 && argv[1] == "--benchmark"s) 
+    {
+        BenchmarkPrefixQuery();
+        return 0;
+    }
+
     SearchServer search_server("и в на"s);
     RequestQueue request_queue(search_server);
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <string>
+
+// Аллокатор, который ведёт учёт выделенных байт во внешнем счётчике.
+// Счётчик по умолчанию отсутствует — такой аллокатор ничего не учитывает
+template <typename T>
+class TrackingAllocator
+{
+public:
+
+    using value_type = T;
+
+    TrackingAllocator() noexcept = default;
+
+    explicit TrackingAllocator(std::size_t* counter) noexcept
+        : counter_(counter)
+        {}
+
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U>& other) noexcept
+        : counter_(other.GetCounter())
+        {}
+
+    T* allocate(std::size_t n)
+    {
+        T* result = static_cast<T*>(::operator new(n * sizeof(T)));
+        if (counter_)
+        {
+            *counter_ += n * sizeof(T);
+        }
+        return result;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (counter_)
+        {
+            *counter_ -= n * sizeof(T);
+        }
+        ::operator delete(p);
+    }
+
+    std::size_t* GetCounter() const noexcept
+    {
+        return counter_;
+    }
+
+private:
+
+    std::size_t* counter_ = nullptr;
+};
+
+template <typename T, typename U>
+bool operator == (const TrackingAllocator<T>& lhs, const TrackingAllocator<U>& rhs) noexcept
+{
+    return lhs.GetCounter() == rhs.GetCounter();
+}
+
+template <typename T, typename U>
+bool operator != (const TrackingAllocator<T>& lhs, const TrackingAllocator<U>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+// Строки хранят символы через собственный аллокатор, поэтому их память в куче
+// учитывается отдельно. Короткие строки помещаются в буфер самого объекта (SSO)
+inline std::size_t GetStringHeapSize(const std::string& str)
+{
+    return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+}
+
+struct MemoryStats
+{
+    std::size_t word_to_document_freqs = 0;
+    std::size_t documents = 0;
+    std::size_t document_ids = 0;
+    std::size_t stop_words = 0;
+    std::size_t spilled_words = 0;   // каталог вытесненных на диск списков
+    std::size_t request_queue = 0;
+    std::size_t spilled_to_disk = 0; // размер файла вытеснения, в RAM не входит
+
+    std::size_t Total() const
+    {
+        return word_to_document_freqs + documents + document_ids
+             + stop_words + spilled_words + request_queue;
+    }
+};
@@ -0,0 +1,55 @@
+#include "posting_store.h"
+
+#include <cstdio>
+
+PostingStore::PostingStore(const std::string& path)
+    : path_(path)
+    , file_(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc)
+{
+    if (!file_)
+    {
+        throw std::ios_base::failure("не удалось открыть файл вытеснения "s + path_);
+    }
+}
+
+PostingStore::~PostingStore()
+{
+    file_.close();
+    std::remove(path_.c_str());
+}
+
+std::vector<PostingStore::Posting> PostingStore::Read(const Segment& segment) const
+{
+    std::vector<Posting> postings(segment.count);
+
+    std::lock_guard guard(file_mutex_);
+    file_.clear();
+    file_.seekg(segment.offset);
+    for (auto &[document_id, term_freq] : postings)
+    {
+        file_.read(reinterpret_cast<char*>(&document_id), sizeof(document_id));
+        file_.read(reinterpret_cast<char*>(&term_freq), sizeof(term_freq));
+    }
+    if (!file_)
+    {
+        throw std::ios_base::failure("ошибка чтения из файла вытеснения "s + path_);
+    }
+
+    return postings;
+}
+
+std::size_t PostingStore::GetFileSize() const
+{
+    return static_cast<std::size_t>(file_size_);
+}
+
+const std::string& PostingStore::GetPath() const
+{
+    return path_;
+}
+
+void PostingStore::WritePosting(int document_id, double term_freq)
+{
+    file_.write(reinterpret_cast<const char*>(&document_id), sizeof(document_id));
+    file_.write(reinterpret_cast<const char*>(&term_freq), sizeof(term_freq));
+}
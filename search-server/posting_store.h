@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std::string_literals;
+
+// Файловое хранилище списков документов (posting lists), вытесненных из памяти.
+// Записи только дописываются в конец файла, место слитых сегментов не переиспользуется.
+// Файл удаляется вместе с хранилищем
+class PostingStore
+{
+public:
+
+    struct Segment
+    {
+        std::streamoff offset;
+        std::size_t count;
+    };
+
+    using Posting = std::pair<int, double>;
+    static const std::size_t POSTING_SIZE = sizeof(int) + sizeof(double);
+
+    explicit PostingStore(const std::string& path);
+    ~PostingStore();
+
+    PostingStore(const PostingStore&) = delete;
+    PostingStore& operator = (const PostingStore&) = delete;
+
+    template <typename PostingContainer>
+    Segment Write(const PostingContainer& postings);
+    std::vector<Posting> Read(const Segment& segment) const;
+
+    std::size_t GetFileSize() const;
+    const std::string& GetPath() const;
+
+private:
+
+    std::string path_;
+    mutable std::fstream file_;
+    mutable std::mutex file_mutex_;
+    std::streamoff file_size_ = 0;
+
+    void WritePosting(int document_id, double term_freq);
+};
+
+template <typename PostingContainer>
+PostingStore::Segment PostingStore::Write(const PostingContainer& postings)
+{
+    std::lock_guard guard(file_mutex_);
+
+    const Segment segment{ file_size_, postings.size() };
+    // после неудачной записи поток в состоянии ошибки; недописанный хвост будет перезаписан
+    file_.clear();
+    file_.seekp(file_size_);
+    for (const auto &[document_id, term_freq] : postings)
+    {
+        WritePosting(document_id, term_freq);
+    }
+    if (!file_)
+    {
+        throw std::ios_base::failure("ошибка записи в файл вытеснения "s + path_);
+    }
+    file_size_ += static_cast<std::streamoff>(segment.count * POSTING_SIZE);
+
+    return segment;
+}
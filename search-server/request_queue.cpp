@@ -1,7 +1,9 @@
 #include "request_queue.h"
 
 RequestQueue::RequestQueue(const SearchServer& search_server)
-    : search_server_(search_server)
+    : requests_memory_(std::make_unique<std::size_t>(0))
+    , requests_(TrackingAllocator<QueryResult>(requests_memory_.get()))
+    , search_server_(search_server)
     , no_results_requests_(0)
     , current_time_(0) 
     {}
@@ -27,6 +29,14 @@ int RequestQueue::GetNoResultRequests() const
     return no_results_requests_;
 }
 
+MemoryStats RequestQueue::GetMemoryStats() const 
+{
+    MemoryStats stats = search_server_.GetMemoryStats();
+    stats.request_queue = *requests_memory_;
+
+    return stats;
+}
+
 void RequestQueue::AddRequest(int results_num) 
 {
     // новый запрос - новая секунда
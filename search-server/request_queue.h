@@ -1,7 +1,9 @@
 #pragma once
 
 #include <deque>
+#include <memory>
 #include "document.h"
+#include "memory_tracking.h"
 #include "search_server.h"
 
 class RequestQueue 
@@ -17,6 +19,8 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query);
     
     int GetNoResultRequests() const;
+    // статистика сервера, дополненная памятью очереди запросов
+    MemoryStats GetMemoryStats() const;
 
 private:
 
@@ -26,7 +30,8 @@ private:
         int results;
     };
 
-    std::deque<QueryResult> requests_;
+    std::unique_ptr<std::size_t> requests_memory_;
+    std::deque<QueryResult, TrackingAllocator<QueryResult>> requests_;
     const SearchServer& search_server_;
     int no_results_requests_;
     int current_time_;
@@ -36,7 +41,7 @@ private:
 };
 
 template <typename DocumentPredicate>
-std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) 
+std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) 
 {
     const auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
     AddRequest(result.size());
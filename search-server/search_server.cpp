@@ -19,10 +19,23 @@ void SearchServer::AddDocument(int document_id, const std::string& document, Doc
 
     const std::vector<std::string> words = SplitIntoWordsNoStop(document);
     for (auto& word : words) {
-        word_to_document_freqs_[word][document_id] += 1.0 / words.size();
+        const auto [it, inserted] = word_to_document_freqs_.try_emplace(word);
+        if (inserted) {
+            memory_counters_->word_to_document_freqs += GetStringHeapSize(it->first);
+        }
+        it->second.freqs[document_id] += 1.0 / words.size();
     }
     documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
     document_ids_.push_back(document_id);
+
+    if (memory_limit_ > 0 && memory_counters_->word_to_document_freqs > memory_limit_) {
+        try {
+            SpillPostingLists();
+        }
+        catch (const std::ios_base::failure&) {
+            // документ уже добавлен; не вытесненные списки остаются в памяти
+        }
+    }
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentStatus status) const {
@@ -49,18 +62,24 @@ std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument
 
     std::vector<std::string> matched_words;
     for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+        if (WordContainsDocument(word, document_id)) {
+            matched_words.push_back(word);
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+    }
+    for (const std::string& word : query.plus_prefix_words) {
+        if (WordContainsDocument(word, document_id)) {
             matched_words.push_back(word);
         }
     }
+    sort(matched_words.begin(), matched_words.end());
     for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+        if (WordContainsDocument(word, document_id)) {
+            matched_words.clear();
+            break;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+    }
+    for (const std::string& prefix : query.minus_prefixes) {
+        if (WordWithPrefixContainsDocument(prefix, document_id)) {
             matched_words.clear();
             break;
         }
@@ -69,6 +88,173 @@ std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument
     return { matched_words, documents_.at(document_id).status };
 }
 
+MemoryStats SearchServer::GetMemoryStats() const {
+    MemoryStats stats;
+    stats.word_to_document_freqs = memory_counters_->word_to_document_freqs;
+    stats.documents = memory_counters_->documents;
+    stats.document_ids = memory_counters_->document_ids;
+    stats.stop_words = memory_counters_->stop_words;
+    stats.spilled_words = memory_counters_->spilled_words;
+    stats.spilled_to_disk = posting_store_ ? posting_store_->GetFileSize() : 0;
+    return stats;
+}
+
+void SearchServer::SetMemoryLimit(std::size_t max_bytes, const std::string& spill_path) {
+    if (max_bytes == 0) {
+        memory_limit_ = 0;
+        return;
+    }
+    if (posting_store_ && spill_path_ != spill_path) {
+        throw std::invalid_argument("файл вытеснения уже задан: "s + spill_path_);
+    }
+    memory_limit_ = max_bytes;
+    if (!posting_store_) {
+        spill_path_ = spill_path;
+        posting_store_ = std::make_unique<PostingStore>(spill_path_);
+    }
+
+    if (memory_counters_->word_to_document_freqs > memory_limit_) {
+        SpillPostingLists();
+    }
+}
+
+void SearchServer::SetMaxPrefixExpansions(std::size_t max_expansions) {
+    max_prefix_expansions_ = max_expansions;
+}
+
+void SearchServer::SpillPostingLists() {
+    // Первыми вытесняются списки слов, к которым дольше всего не обращались запросы
+    // (слова, которые ещё не искали, — раньше всех); при равенстве — более длинные,
+    // они освобождают больше памяти. Вытесняем до половины лимита, чтобы не писать
+    // на диск при каждом добавлении
+    const std::size_t target_size = memory_limit_ / 2;
+    std::vector<WordToDocumentFreqs::iterator> candidates;
+    candidates.reserve(word_to_document_freqs_.size());
+    for (auto it = word_to_document_freqs_.begin(); it != word_to_document_freqs_.end(); ++it) {
+        candidates.push_back(it);
+    }
+    sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        const std::uint64_t lhs_access = lhs->second.last_access;
+        const std::uint64_t rhs_access = rhs->second.last_access;
+        if (lhs_access != rhs_access) {
+            return lhs_access < rhs_access;
+        }
+        return lhs->second.freqs.size() > rhs->second.freqs.size();
+    });
+
+    for (const auto it : candidates) {
+        if (memory_counters_->word_to_document_freqs <= target_size) {
+            break;
+        }
+        SpillWord(it);
+    }
+
+    // слитые сегменты остаются в файле мёртвыми записями; переписываем живые,
+    // когда мёртвые начинают преобладать
+    if (posting_store_->GetFileSize() > 2 * spilled_posting_count_ * PostingStore::POSTING_SIZE) {
+        CompactPostingStore();
+    }
+}
+
+void SearchServer::SpillWord(WordToDocumentFreqs::iterator it) {
+    // сначала запись: если она не удастся, список останется в памяти без изменений
+    const PostingStore::Segment segment = posting_store_->Write(it->second.freqs);
+
+    auto [spilled, inserted] = spilled_words_.try_emplace(it->first);
+    if (inserted) {
+        memory_counters_->spilled_words += GetStringHeapSize(spilled->first);
+    }
+    spilled->second.push_back(segment);
+    spilled_posting_count_ += segment.count;
+
+    memory_counters_->word_to_document_freqs -= GetStringHeapSize(it->first);
+    word_to_document_freqs_.erase(it);
+
+    MergeTailSegments(spilled->second);
+}
+
+void SearchServer::MergeTailSegments(Segments& segments) {
+    // Новый сегмент сливается с предыдущим, пока тот не длиннее: длины сегментов слова
+    // убывают не медленнее чем вдвое, поэтому их O(log n), а каждая запись
+    // переписывается O(log n) раз
+    while (segments.size() >= 2 && segments[segments.size() - 2].count <= segments.back().count) {
+        const Segments tail(segments.end() - 2, segments.end(), segments.get_allocator());
+        const PostingStore::Segment merged = posting_store_->Write(ReadSegments(tail));
+        segments.pop_back();
+        segments.back() = merged;
+    }
+}
+
+std::vector<PostingStore::Posting> SearchServer::ReadSegments(const Segments& segments) const {
+    // документ попадает ровно в один сегмент, каждый сегмент упорядочен по id
+    std::vector<PostingStore::Posting> postings;
+    for (const PostingStore::Segment& segment : segments) {
+        const auto segment_postings = posting_store_->Read(segment);
+        const auto middle = postings.insert(postings.end(), segment_postings.begin(), segment_postings.end());
+        inplace_merge(postings.begin(), middle, postings.end());
+    }
+    return postings;
+}
+
+void SearchServer::CompactPostingStore() {
+    // новый файл пишется рядом со старым, затем старый удаляется вместе с прежним хранилищем;
+    // сегменты каждого слова при этом сливаются в один
+    const std::string compacted_path = posting_store_->GetPath() == spill_path_ 
+                                        ? spill_path_ + ".compact"s : spill_path_;
+    auto compacted = std::make_unique<PostingStore>(compacted_path);
+    std::vector<PostingStore::Segment> compacted_segments;
+    for (const auto& [word, segments] : spilled_words_) {
+        compacted_segments.push_back(compacted->Write(ReadSegments(segments)));
+    }
+
+    // сегменты переключаются на новый файл только после успешной записи всех
+    auto compacted_segment = compacted_segments.begin();
+    for (auto& [word, segments] : spilled_words_) {
+        segments.assign(1, *compacted_segment++);
+    }
+    posting_store_ = std::move(compacted);
+}
+
+const SearchServer::WordPostings* SearchServer::FindWordPostings(const std::string& word) const {
+    const auto it = word_to_document_freqs_.find(word);
+    if (it == word_to_document_freqs_.end()) {
+        return nullptr;
+    }
+    it->second.last_access.store(++*access_clock_, std::memory_order_relaxed);
+    return &it->second;
+}
+
+bool SearchServer::HasWord(const std::string& word) const {
+    return word_to_document_freqs_.count(word) > 0 || spilled_words_.count(word) > 0;
+}
+
+std::size_t SearchServer::GetWordDocumentCount(const std::string& word) const {
+    std::size_t count = 0;
+    if (const auto it = word_to_document_freqs_.find(word); it != word_to_document_freqs_.end()) {
+        count += it->second.freqs.size();
+    }
+    if (const auto it = spilled_words_.find(word); it != spilled_words_.end()) {
+        for (const PostingStore::Segment& segment : it->second) {
+            count += segment.count;
+        }
+    }
+    return count;
+}
+
+bool SearchServer::WordContainsDocument(const std::string& word, int document_id) const {
+    if (const WordPostings* postings = FindWordPostings(word); postings && postings->freqs.count(document_id)) {
+        return true;
+    }
+    if (spilled_words_.count(word) == 0) {
+        return false;
+    }
+    bool found = false;
+    ForEachWordDocument(word, [&found, document_id](int id, double) {
+        found = found || id == document_id;
+    });
+    return found;
+}
+
 bool SearchServer::IsStopWord(const std::string& word) const {
     return stop_words_.count(word) > 0;
 }
@@ -104,6 +290,14 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
+SearchServer::StopWords SearchServer::MakeStopWords(const std::set<std::string>& words, std::size_t* counter) {
+    StopWords stop_words(words.begin(), words.end(), TrackingAllocator<std::string>(counter));
+    for (const std::string& word : stop_words) {
+        *counter += GetStringHeapSize(word);
+    }
+    return stop_words;
+}
+
 SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
     QueryWord result;
 
@@ -118,8 +312,15 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
     if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
         throw std::invalid_argument("наличие более чем одного минуса перед словами"s);
     }
+    if (text.back() == '*') {
+        text.pop_back();
+        if (text.empty()) {
+            throw std::invalid_argument("отсутствие текста перед символом «*» в поисковом запросе"s);
+        }
+        return { text, is_minus, false, true };
+    }
 
-    return { text, is_minus, IsStopWord(text) };
+    return { text, is_minus, IsStopWord(text), false };
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
@@ -128,21 +329,100 @@ SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
     for (const std::string& word : SplitIntoWords(text)) {
         QueryWord query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
-            if (query_word.is_minus) {
+            if (query_word.is_minus && query_word.is_prefix) {
+                result.minus_prefixes.insert(query_word.data);
+            }
+            else if (query_word.is_minus) {
                 result.minus_words.insert(query_word.data);
             }
+            else if (query_word.is_prefix) {
+                ExpandPrefix(query_word.data, max_prefix_expansions_, result.plus_prefix_words);
+            }
             else {
                 result.plus_words.insert(query_word.data);
             }
         }
     }
+    // слово, заданное и явно, и через префикс, учитывается один раз
+    for (const std::string& word : result.plus_words) {
+        result.plus_prefix_words.erase(word);
+    }
     return result;
 }
 
+void SearchServer::ExpandPrefix(const std::string& prefix, std::size_t max_expansions, 
+                                std::set<std::string>& words) const {
+    std::size_t count = 0;
+    ForEachWordWithPrefix(prefix, [&](const std::string& word) {
+        if (count == max_expansions) {
+            return false;
+        }
+        words.insert(word);
+        ++count;
+        return true;
+    });
+}
+
+bool SearchServer::WordWithPrefixContainsDocument(const std::string& prefix, int document_id) const {
+    bool found = false;
+    ForEachWordWithPrefix(prefix, [&](const std::string& word) {
+        found = WordContainsDocument(word, document_id);
+        return !found;
+    });
+    return found;
+}
+
+std::vector<std::pair<int, double>> SearchServer::ComputeRelevanceByWords(const std::set<std::string>& words) const {
+    std::vector<std::pair<int, double>> contributions;
+    for (const std::string& word : words) {
+        if (!HasWord(word)) {
+            continue;
+        }
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+        ForEachWordDocument(word, [&](int document_id, double term_freq) {
+            contributions.emplace_back(document_id, term_freq * inverse_document_freq);
+        });
+    }
+
+    // устойчивая сортировка сохраняет порядок слов, поэтому вклады документа складываются
+    // в том же порядке, что и при поочерёдном обходе слов, и сумма совпадает до бита
+    stable_sort(contributions.begin(), contributions.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    std::vector<std::pair<int, double>> relevance;
+    for (const auto &[document_id, contribution] : contributions) {
+        if (relevance.empty() || relevance.back().first != document_id) {
+            relevance.emplace_back(document_id, 0.0);
+        }
+        relevance.back().second += contribution;
+    }
+    return relevance;
+}
+
+std::vector<int> SearchServer::FindExcludedDocuments(const Query& query) const {
+    std::vector<int> document_ids;
+    const auto exclude_word_documents = [&](const std::string& word) {
+        ForEachWordDocument(word, [&document_ids](int document_id, double) {
+            document_ids.push_back(document_id);
+        });
+        return true;
+    };
+    for (const std::string& word : query.minus_words) {
+        exclude_word_documents(word);
+    }
+    for (const std::string& prefix : query.minus_prefixes) {
+        ForEachWordWithPrefix(prefix, exclude_word_documents);
+    }
+
+    sort(document_ids.begin(), document_ids.end());
+    document_ids.erase(unique(document_ids.begin(), document_ids.end()), document_ids.end());
+    return document_ids;
+}
+
 double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const 
 {
     return log(GetDocumentCount() * 1.0 
-               / word_to_document_freqs_.at(word).size());
+               / GetWordDocumentCount(word));
 }
 
 void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings) {
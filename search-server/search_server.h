@@ -1,19 +1,28 @@
 #pragma once
 
 #include "document.h"
+#include "memory_tracking.h"
+#include "posting_store.h"
 #include "string_processing.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <scoped_allocator>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace std::string_literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPSILON = 1e-6;
+const std::size_t MAX_PREFIX_EXPANSIONS = 100;
 
 class SearchServer 
 {
@@ -34,6 +43,15 @@ public:
     int GetDocumentId(int index) const;
     std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
 
+    MemoryStats GetMemoryStats() const;
+    // Ограничивает память списков документов (word_to_document_freqs_): при превышении
+    // в файл spill_path вытесняются списки слов, к которым дольше всего не обращались запросы.
+    // Остальные структуры не вытесняются. Лимит 0 отключает вытеснение, файл при этом не создаётся
+    void SetMemoryLimit(std::size_t max_bytes, const std::string& spill_path);
+    // Сколько слов словаря может подставить один префиксный плюс-терм вида слово*.
+    // Минус-термы с префиксом не ограничены: исключаются документы с любым словом с этим префиксом
+    void SetMaxPrefixExpansions(std::size_t max_expansions);
+
 private:
 
     struct DocumentData 
@@ -42,21 +60,85 @@ private:
         DocumentStatus status;
     };
 
-    const std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::vector<int> document_ids_;
+    struct MemoryCounters
+    {
+        std::size_t word_to_document_freqs = 0;
+        std::size_t documents = 0;
+        std::size_t document_ids = 0;
+        std::size_t stop_words = 0;
+        std::size_t spilled_words = 0;
+    };
+
+    template <typename Key, typename Value>
+    using TrackingMap = std::map<Key, Value, std::less<Key>, 
+                            TrackingAllocator<std::pair<const Key, Value>>>;
+    using DocumentFreqs = TrackingMap<int, double>;
+
+    // Список документов слова в памяти и отметка последнего обращения к нему из запроса
+    struct WordPostings
+    {
+        using allocator_type = DocumentFreqs::allocator_type;
+
+        explicit WordPostings(const allocator_type& allocator)
+            : freqs(allocator)
+            {}
+
+        DocumentFreqs freqs;
+        mutable std::atomic<std::uint64_t> last_access = 0;
+    };
+
+    using WordToDocumentFreqs = std::map<std::string, WordPostings, std::less<std::string>,
+                            std::scoped_allocator_adaptor<
+                                TrackingAllocator<std::pair<const std::string, WordPostings>>>>;
+    using StopWords = std::set<std::string, std::less<std::string>, TrackingAllocator<std::string>>;
+    using Segments = std::vector<PostingStore::Segment, TrackingAllocator<PostingStore::Segment>>;
+    using SpilledWords = std::map<std::string, Segments, std::less<std::string>,
+                            std::scoped_allocator_adaptor<
+                                TrackingAllocator<std::pair<const std::string, Segments>>>>;
+
+    // счётчики в куче, чтобы адреса, сохранённые в аллокаторах, переживали перемещение сервера
+    std::unique_ptr<MemoryCounters> memory_counters_;
+    // часы обращений к словам; atomic не перемещается, поэтому тоже в куче
+    std::unique_ptr<std::atomic<std::uint64_t>> access_clock_;
+    const StopWords stop_words_;
+    WordToDocumentFreqs word_to_document_freqs_;
+    TrackingMap<int, DocumentData> documents_;
+    std::vector<int, TrackingAllocator<int>> document_ids_;
+
+    std::size_t max_prefix_expansions_ = MAX_PREFIX_EXPANSIONS;
+    std::size_t memory_limit_ = 0;
+    std::string spill_path_;
+    std::unique_ptr<PostingStore> posting_store_;
+    std::size_t spilled_posting_count_ = 0;
+    SpilledWords spilled_words_;
 
     bool IsStopWord(const std::string& word) const;
     static bool IsValidWord(const std::string& word);
     std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
     static int ComputeAverageRating(const std::vector<int>& ratings);
+    static StopWords MakeStopWords(const std::set<std::string>& words, std::size_t* counter);
+
+    void SpillPostingLists();
+    void SpillWord(WordToDocumentFreqs::iterator it);
+    void MergeTailSegments(Segments& segments);
+    std::vector<PostingStore::Posting> ReadSegments(const Segments& segments) const;
+    void CompactPostingStore();
+
+    // ищет список слова в памяти и отмечает обращение к нему
+    const WordPostings* FindWordPostings(const std::string& word) const;
+
+    bool HasWord(const std::string& word) const;
+    std::size_t GetWordDocumentCount(const std::string& word) const;
+    bool WordContainsDocument(const std::string& word, int document_id) const;
+    template <typename Function>
+    void ForEachWordDocument(const std::string& word, Function function) const;
 
     struct QueryWord 
     {
         std::string data;
         bool is_minus;
         bool is_stop;
+        bool is_prefix;
     };
 
     QueryWord ParseQueryWord(std::string text) const;
@@ -65,9 +147,23 @@ private:
     {
         std::set<std::string> plus_words;
         std::set<std::string> minus_words;
+        // слова, подставленные вместо префиксных плюс-термов, кроме уже входящих в plus_words
+        std::set<std::string> plus_prefix_words;
+        // префиксы минус-термов не раскрываются: словарь обходится при поиске
+        std::set<std::string> minus_prefixes;
     };
 
     Query ParseQuery(const std::string& text) const;
+    void ExpandPrefix(const std::string& prefix, std::size_t max_expansions, 
+                      std::set<std::string>& words) const;
+    template <typename Function>
+    void ForEachWordWithPrefix(const std::string& prefix, Function function) const;
+    bool WordWithPrefixContainsDocument(const std::string& prefix, int document_id) const;
+
+    // Релевантность документов по словам words, упорядоченная по id документа
+    std::vector<std::pair<int, double>> ComputeRelevanceByWords(const std::set<std::string>& words) const;
+    // id документов, содержащих минус-слова запроса, упорядоченные и без повторов
+    std::vector<int> FindExcludedDocuments(const Query& query) const;
     double ComputeWordInverseDocumentFreq(const std::string& word) const;
 
     template<typename DocumentPredicate>
@@ -76,7 +172,14 @@ private:
 
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
-                    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+                    : memory_counters_(std::make_unique<MemoryCounters>())
+                    , access_clock_(std::make_unique<std::atomic<std::uint64_t>>(0))
+                    , stop_words_(MakeStopWords(MakeUniqueNonEmptyStrings(stop_words), 
+                                                &memory_counters_->stop_words))
+                    , word_to_document_freqs_(TrackingAllocator<int>(&memory_counters_->word_to_document_freqs))
+                    , documents_(TrackingAllocator<int>(&memory_counters_->documents))
+                    , document_ids_(TrackingAllocator<int>(&memory_counters_->document_ids))
+                    , spilled_words_(TrackingAllocator<int>(&memory_counters_->spilled_words))
 {
     if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) 
     {
@@ -84,6 +187,73 @@ SearchServer::SearchServer(const StringContainer& stop_words)
     }
 }
 
+// Обходит пары (id документа, TF) слова: сначала из памяти, затем вытесненные в файл
+template <typename Function>
+void SearchServer::ForEachWordDocument(const std::string& word, Function function) const
+{
+    if (const WordPostings* postings = FindWordPostings(word))
+    {
+        for (const auto &[document_id, term_freq] : postings->freqs)
+        {
+            function(document_id, term_freq);
+        }
+    }
+
+    if (const auto it = spilled_words_.find(word); it != spilled_words_.end())
+    {
+        for (const PostingStore::Segment& segment : it->second)
+        {
+            for (const auto &[document_id, term_freq] : posting_store_->Read(segment))
+            {
+                function(document_id, term_freq);
+            }
+        }
+    }
+}
+
+// Обходит слова обоих словарей, начинающиеся с prefix, в лексикографическом порядке,
+// каждое по одному разу. Обход прекращается, когда function(слово) возвращает false
+template <typename Function>
+void SearchServer::ForEachWordWithPrefix(const std::string& prefix, Function function) const
+{
+    // словари упорядочены, поэтому слова с префиксом образуют в каждом непрерывный диапазон
+    const auto has_prefix = [&prefix](const std::string& word)
+    {
+        return word.compare(0, prefix.size(), prefix) == 0;
+    };
+    auto in_memory = word_to_document_freqs_.lower_bound(prefix);
+    auto spilled = spilled_words_.lower_bound(prefix);
+
+    while (true)
+    {
+        const bool has_in_memory = in_memory != word_to_document_freqs_.end() && has_prefix(in_memory->first);
+        const bool has_spilled = spilled != spilled_words_.end() && has_prefix(spilled->first);
+        if (!has_in_memory && !has_spilled)
+        {
+            return;
+        }
+
+        const std::string* word = nullptr;
+        if (has_in_memory && (!has_spilled || in_memory->first <= spilled->first))
+        {
+            // список слова может быть частично в памяти и частично на диске
+            if (has_spilled && in_memory->first == spilled->first)
+            {
+                ++spilled;
+            }
+            word = &(in_memory++)->first;
+        }
+        else
+        {
+            word = &(spilled++)->first;
+        }
+        if (!function(*word))
+        {
+            return;
+        }
+    }
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate status) const 
 {
@@ -92,7 +262,7 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
     
     for (const std::string& word : query.plus_words) 
     {
-        if (word_to_document_freqs_.count(word) == 0) 
+        if (!HasWord(word)) 
         {
             continue;
         }
@@ -100,8 +270,7 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
         const double inverse_document_freq 
                         = ComputeWordInverseDocumentFreq(word);
         
-        for (const auto &[document_id, term_freq] : 
-                            word_to_document_freqs_.at(word)) 
+        ForEachWordDocument(word, [&](int document_id, double term_freq) 
         {
             if (status(document_id, documents_.at(document_id).status, 
                         documents_.at(document_id).rating)) 
@@ -109,22 +278,48 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
                 document_to_relevance[document_id] 
                     += term_freq * inverse_document_freq;
             }
-        }
+        });
+    }
+
+    // Префиксные термы дают сотни слов: их вклады собираются в плоский вектор, упорядоченный
+    // по id, и документ проверяется один раз, а не при каждом вхождении в списки
+    const std::vector<std::pair<int, double>> prefix_relevance = ComputeRelevanceByWords(query.plus_prefix_words);
+    const std::vector<int> excluded_documents = FindExcludedDocuments(query);
+
+    for (const int document_id : excluded_documents) 
+    {
+        document_to_relevance.erase(document_id);
     }
 
-    for (const std::string& word : query.minus_words) 
+    // без обычных плюс-слов результат собирается сразу, в том же порядке по id
+    const bool collect_directly = document_to_relevance.empty();
+    auto excluded = excluded_documents.begin();
+    for (const auto &[document_id, relevance] : prefix_relevance) 
     {
-        if (word_to_document_freqs_.count(word) == 0) 
+        while (excluded != excluded_documents.end() && *excluded < document_id) 
+        {
+            ++excluded;
+        }
+        if (excluded != excluded_documents.end() && *excluded == document_id) 
         {
             continue;
         }
-            for (const auto &[document_id, term_freq] : 
-                                word_to_document_freqs_.at(word)) 
-            {
-                document_to_relevance.erase(document_id);
-            }
+
+        const DocumentData& document = documents_.at(document_id);
+        if (!status(document_id, document.status, document.rating)) 
+        {
+            continue;
+        }
+        if (collect_directly) 
+        {
+            matched_documents.push_back({ document_id, relevance, document.rating });
+        }
+        else 
+        {
+            document_to_relevance[document_id] += relevance;
+        }
     }
-    
+
     for (const auto &[document_id, relevance] : document_to_relevance) 
     {
         matched_documents.push_back({ document_id, relevance, 
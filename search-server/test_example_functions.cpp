@@ -0,0 +1,385 @@
+#include "test_example_functions.h"
+#include "line_server.h"
+#include "log_duration.h"
+#include "request_queue.h"
+#include "search_server.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace
+{
+
+const int TEST_CORPUS_DOCUMENT_COUNT = 2000;
+const int BENCHMARK_CORPUS_DOCUMENT_COUNT = 20000;
+const int CORPUS_DICTIONARY_SIZE = 3000;
+const int CORPUS_WORDS_PER_DOCUMENT = 10;
+
+std::string MakeCorpusDocument(std::mt19937& generator, int dictionary_size)
+{
+    std::string document;
+    for (int i = 0; i < CORPUS_WORDS_PER_DOCUMENT; ++i)
+    {
+        document += "w"s + std::to_string(generator() % dictionary_size) + " "s;
+    }
+    return document;
+}
+
+// Документы из слов w0..w2999; с префиксом w12 их 111: w12, w120..w129, w1200..w1299
+void AddCorpus(SearchServer& search_server, int document_count = TEST_CORPUS_DOCUMENT_COUNT)
+{
+    std::mt19937 generator(1);
+    for (int document_id = 0; document_id < document_count; ++document_id)
+    {
+        const std::string document = MakeCorpusDocument(generator, CORPUS_DICTIONARY_SIZE);
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL,
+                                  { static_cast<int>(generator() % 10) });
+    }
+}
+
+std::string GetTestSpillPath(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::vector<std::string> GetCorpusWordsWithPrefix(const std::string& prefix)
+{
+    std::vector<std::string> words;
+    for (int i = 0; i < CORPUS_DICTIONARY_SIZE; ++i)
+    {
+        const std::string word = "w"s + std::to_string(i);
+        if (word.compare(0, prefix.size(), prefix) == 0)
+        {
+            words.push_back(word);
+        }
+    }
+    return words;
+}
+
+std::string JoinWords(const std::vector<std::string>& words, const std::string& word_prefix = {})
+{
+    std::string text;
+    for (const std::string& word : words)
+    {
+        text += word_prefix + word + " "s;
+    }
+    return text;
+}
+
+void AssertSameDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs)
+{
+    assert(lhs.size() == rhs.size());
+    for (size_t i = 0; i < lhs.size(); ++i)
+    {
+        assert(lhs[i].id == rhs[i].id);
+        assert(std::abs(lhs[i].relevance - rhs[i].relevance) < EPSILON);
+        assert(lhs[i].rating == rhs[i].rating);
+    }
+}
+
+void TestMemoryStatsGrowWithDocuments()
+{
+    SearchServer search_server("и в на"s);
+    const MemoryStats empty_stats = search_server.GetMemoryStats();
+    assert(empty_stats.stop_words > 0);
+    assert(empty_stats.documents == 0 && empty_stats.document_ids == 0);
+
+    search_server.AddDocument(1, "пушистый кот"s, DocumentStatus::ACTUAL, { 1 });
+    const MemoryStats one_document_stats = search_server.GetMemoryStats();
+    search_server.AddDocument(2, "модный пёс"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "большой скворец"s, DocumentStatus::ACTUAL, { 1 });
+    const MemoryStats stats = search_server.GetMemoryStats();
+    assert(one_document_stats.documents > 0 && stats.documents > one_document_stats.documents);
+    assert(one_document_stats.document_ids > 0 && stats.document_ids > one_document_stats.document_ids);
+    assert(stats.word_to_document_freqs > one_document_stats.word_to_document_freqs);
+    assert(stats.stop_words == empty_stats.stop_words);
+    assert(stats.spilled_words == 0 && stats.spilled_to_disk == 0);
+
+    RequestQueue request_queue(search_server);
+    const std::size_t empty_queue_memory = request_queue.GetMemoryStats().request_queue;
+    for (int i = 0; i < 100; ++i)
+    {
+        request_queue.AddFindRequest("кот"s);
+    }
+    const MemoryStats queue_stats = request_queue.GetMemoryStats();
+    assert(queue_stats.request_queue > empty_queue_memory);
+    assert(queue_stats.documents == stats.documents);
+    assert(queue_stats.Total() == stats.Total() + queue_stats.request_queue);
+}
+
+void TestSpilledIndexStaysWithinLimit()
+{
+    const int document_count = 3000;
+    const int dictionary_size = 300;
+    const std::size_t memory_limit = 20000;
+    const std::vector<std::string> queries = { "w1 w2 -w3"s, "w100 w200"s, "w299"s, "w7 w70 w170"s };
+
+    SearchServer search_server(""s);
+    SearchServer spilled_search_server(""s);
+    spilled_search_server.SetMemoryLimit(memory_limit, GetTestSpillPath("test_spilled_index.spill"s));
+
+    const auto assert_same_results = [&]
+    {
+        for (const std::string& query : queries)
+        {
+            const auto expected = search_server.FindTopDocuments(query);
+            const auto actual = spilled_search_server.FindTopDocuments(query);
+            assert(expected.size() == actual.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                assert(expected[i].id == actual[i].id && expected[i].relevance == actual[i].relevance);
+            }
+        }
+    };
+
+    std::mt19937 generator(1);
+    std::size_t spill_count = 0;
+    std::size_t compaction_count = 0;
+    std::size_t spilled_to_disk = 0;
+    for (int document_id = 0; document_id < document_count; ++document_id)
+    {
+        const std::string document = MakeCorpusDocument(generator, dictionary_size);
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { 1 });
+        spilled_search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { 1 });
+
+        const MemoryStats stats = spilled_search_server.GetMemoryStats();
+        assert(stats.word_to_document_freqs <= memory_limit);
+        if (stats.spilled_to_disk > spilled_to_disk)
+        {
+            ++spill_count;
+            // повторные вытеснения дописывают сегменты к уже вытесненным словам
+            if (spill_count > 1 && spill_count % 20 == 0)
+            {
+                assert_same_results();
+            }
+        }
+        else if (stats.spilled_to_disk < spilled_to_disk)
+        {
+            // файл уменьшается только при уплотнении
+            ++compaction_count;
+            assert_same_results();
+        }
+        spilled_to_disk = stats.spilled_to_disk;
+    }
+    assert(spill_count > 1);
+    assert(compaction_count > 0);
+    assert_same_results();
+}
+
+void TestPrefixQueryRanksLikeOrQuery()
+{
+    SearchServer search_server(""s);
+    AddCorpus(search_server);
+    const std::vector<std::string> words = GetCorpusWordsWithPrefix("w12"s);
+    search_server.SetMaxPrefixExpansions(words.size());
+
+    const auto prefix_result = search_server.FindTopDocuments("w12*"s);
+    assert(!prefix_result.empty());
+    AssertSameDocuments(prefix_result, search_server.FindTopDocuments(JoinWords(words)));
+    AssertSameDocuments(search_server.FindTopDocuments("w5 w7 -w12*"s),
+                        search_server.FindTopDocuments("w5 w7 "s + JoinWords(words, "-"s)));
+}
+
+void TestPrefixQueryOnSpilledIndex()
+{
+    SearchServer search_server(""s);
+    SearchServer spilled_search_server(""s);
+    spilled_search_server.SetMemoryLimit(100000, GetTestSpillPath("test_prefix_query.spill"s));
+    AddCorpus(search_server);
+    AddCorpus(spilled_search_server);
+    assert(spilled_search_server.GetMemoryStats().spilled_to_disk > 0);
+
+    search_server.SetMaxPrefixExpansions(1000);
+    spilled_search_server.SetMaxPrefixExpansions(1000);
+    for (const std::string& query : { "w12* -w3*"s, "w1 w12* -w5*"s })
+    {
+        AssertSameDocuments(spilled_search_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+    }
+    for (int document_id = 0; document_id < 50; ++document_id)
+    {
+        assert(spilled_search_server.MatchDocument("w1* -w12*"s, document_id)
+               == search_server.MatchDocument("w1* -w12*"s, document_id));
+    }
+}
+
+void TestPrefixExpansionLimit()
+{
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "ab abc abd abe"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.SetMaxPrefixExpansions(2);
+
+    const auto [words, status] = search_server.MatchDocument("ab*"s, 1);
+    assert((words == std::vector<std::string>{ "ab"s, "abc"s }));
+}
+
+void TestMinusPrefixIsNotLimited()
+{
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "кот пушистый"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "кот пушистая"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "кот пушистое"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.SetMaxPrefixExpansions(1);
+
+    assert(search_server.FindTopDocuments("кот -пушист*"s).empty());
+    assert(std::get<0>(search_server.MatchDocument("кот -пушист*"s, 3)).empty());
+    assert(search_server.FindTopDocuments("кот -пуш*"s).empty());
+    assert(search_server.FindTopDocuments("кот -пушистый*"s).size() == 2);
+}
+
+void TestPrefixWithoutTextIsRejected()
+{
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "кот"s, DocumentStatus::ACTUAL, { 1 });
+    for (const std::string& query : { "*"s, "-*"s })
+    {
+        try
+        {
+            search_server.FindTopDocuments(query);
+            assert(false);
+        }
+        catch (const std::invalid_argument&)
+        {
+        }
+    }
+}
+
+std::string RunLineServerOnText(SearchServer& search_server, const std::string& input,
+                                const LineServerOptions& options)
+{
+    std::istringstream in(input);
+    std::ostringstream out;
+    RunLineServer(search_server, in, out, options);
+    return out.str();
+}
+
+void TestLineServerKeepsResponseOrder()
+{
+    SearchServer search_server(""s);
+    std::mt19937 generator(1);
+    for (int document_id = 0; document_id < 200; ++document_id)
+    {
+        search_server.AddDocument(document_id, MakeCorpusDocument(generator, 50), DocumentStatus::ACTUAL, { 1 });
+    }
+    std::string input;
+    for (int i = 0; i < 300; ++i)
+    {
+        input += i % 3 == 0 ? "match "s + std::to_string(i % 200) + " w"s + std::to_string(i % 50) + "\n"s
+                            : "search w"s + std::to_string(i % 50) + " w"s + std::to_string(i % 7) + "\n"s;
+    }
+
+    const std::string expected = RunLineServerOnText(search_server, input, { 1, 1024, 1 << 16 });
+    assert(expected.rfind("{ document_id = 0, status = 0, words ="s, 0) == 0);
+    // окно в два ответа и крошечный буфер вывода не меняют ни порядок, ни содержимое
+    assert(RunLineServerOnText(search_server, input, { 4, 2, 16 }) == expected);
+    assert(RunLineServerOnText(search_server, input, { 8, 1024, 1 << 16 }) == expected);
+}
+
+void TestLineServerAddIsBarrier()
+{
+    SearchServer search_server(""s);
+    const std::string output = RunLineServerOnText(search_server,
+        "search кот\nadd 1 3 пушистый кот\nsearch кот\n"s, { 4, 1024, 1 << 16 });
+    assert(output == "Результаты поиска по запросу: кот\n"s
+                     "Документ 1 добавлен\n"s
+                     "Результаты поиска по запросу: кот\n"s
+                     "{ document_id = 1, relevance = 0, rating = 3 }\n"s);
+}
+
+void TestLineServerReportsBadCommands()
+{
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "пушистый кот"s, DocumentStatus::ACTUAL, { 1 });
+    const std::string output = RunLineServerOnText(search_server,
+        "match x кот\nfoo bar\nmatch 1 кот\nadd y 1 пёс\n"s, { 2, 1024, 1 << 16 });
+    const std::string expected_prefix = "Ошибка матчинга: некорректный id документа x\n"s
+                                        "Неизвестная команда: foo\n"s
+                                        "{ document_id = 1, status = 0, words = кот}\n"s
+                                        "Ошибка добавления документа y: "s;
+    assert(output.rfind(expected_prefix, 0) == 0);
+    assert(search_server.GetDocumentCount() == 1);
+}
+
+} // namespace
+
+void TestSearchServer()
+{
+    TestMemoryStatsGrowWithDocuments();
+    TestSpilledIndexStaysWithinLimit();
+    TestLineServerKeepsResponseOrder();
+    TestLineServerAddIsBarrier();
+    TestLineServerReportsBadCommands();
+    TestPrefixQueryRanksLikeOrQuery();
+    TestPrefixQueryOnSpilledIndex();
+    TestPrefixExpansionLimit();
+    TestMinusPrefixIsNotLimited();
+    TestPrefixWithoutTextIsRejected();
+    std::cerr << "TestSearchServer OK"s << std::endl;
+}
+
+void BenchmarkPrefixQuery()
+{
+    const int repeat_count = 20;
+
+    SearchServer search_server(""s);
+    AddCorpus(search_server, BENCHMARK_CORPUS_DOCUMENT_COUNT);
+    const std::vector<std::string> words = GetCorpusWordsWithPrefix("w12"s);
+    const std::string or_query = JoinWords(words);
+    search_server.SetMaxPrefixExpansions(words.size());
+
+    {
+        LOG_DURATION("prefix query w12* x "s + std::to_string(repeat_count));
+        for (int i = 0; i < repeat_count; ++i)
+        {
+            search_server.FindTopDocuments("w12*"s);
+        }
+    }
+    // тот же результат через явное перечисление всех слов
+    {
+        LOG_DURATION(std::to_string(words.size()) + "-word query x "s + std::to_string(repeat_count));
+        for (int i = 0; i < repeat_count; ++i)
+        {
+            search_server.FindTopDocuments(or_query);
+        }
+    }
+    // Клиент без префиксных запросов: по запросу на слово и слияние ответов у себя.
+    // Ему доступны только лучшие документы каждого ответа, поэтому ранжирование приближённое
+    {
+        LOG_DURATION(std::to_string(words.size()) + " separate queries + client merge x "s
+                     + std::to_string(repeat_count));
+        for (int i = 0; i < repeat_count; ++i)
+        {
+            std::map<int, Document> merged;
+            for (const std::string& word : words)
+            {
+                for (const Document& document : search_server.FindTopDocuments(word))
+                {
+                    auto [it, inserted] = merged.emplace(document.id, document);
+                    if (!inserted)
+                    {
+                        it->second.relevance += document.relevance;
+                    }
+                }
+            }
+            std::vector<Document> result;
+            for (const auto &[document_id, document] : merged)
+            {
+                result.push_back(document);
+            }
+            sort(result.begin(), result.end(), [](const Document& lhs, const Document& rhs)
+            {
+                return lhs.relevance > rhs.relevance;
+            });
+            result.resize(std::min<size_t>(result.size(), MAX_RESULT_DOCUMENT_COUNT));
+        }
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+void TestSearchServer();
+
+// Сравнивает префиксный запрос с явным перечислением подставленных слов и с отдельными
+// запросами по каждому слову, слитыми на стороне клиента. Запускается ключом --benchmark
+void BenchmarkPrefixQuery();